@@ -0,0 +1,221 @@
+// tests for the direct-fill functions of vl_vector.
+// build: g++ -std=c++11 tests/vl_vector_test.cpp && ./a.out
+#include "../vl_vector.cpp"
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+
+#define STATIC_CAP 16
+
+// like assert, but always evaluates its argument, also with NDEBUG
+#define CHECK(cond) \
+  do \
+    { \
+      if (!(cond)) \
+        { \
+          fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                  #cond); \
+          exit(EXIT_FAILURE); \
+        } \
+    } \
+  while (0)
+
+// writes a given text to a new pipe and closes its write end
+/// \param text the text to write
+/// \return the read end of the pipe
+int pipe_with (const char * text)
+{
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  size_t len = strlen(text);
+  CHECK(write(fds[1], text, len) == (ssize_t) len);
+  close(fds[1]);
+  return fds[0];
+}
+
+void test_append_uninitialized ()
+{
+  vl_vector<char, STATIC_CAP> vec;
+  char * tail = vec.append_uninitialized(10);
+  CHECK(vec.size() == 10 && vec.capacity() == STATIC_CAP);
+  CHECK(tail == vec.data());
+  tail = vec.append_uninitialized(10);
+  CHECK(vec.size() == 20 && vec.capacity() == 2 * STATIC_CAP);
+  CHECK(tail == vec.data() + 10);
+
+  bool thrown = false;
+  try
+    {
+      vec.append_uninitialized(SIZE_MAX);
+    }
+  catch (const std::length_error&)
+    {
+      thrown = true;
+    }
+  CHECK(thrown && vec.size() == 20);
+}
+
+void test_append_n ()
+{
+  vl_vector<int, STATIC_CAP> vec;
+  int next = 0;
+  auto counter = [&next] () {return next++;};
+  vec.append_n(10, counter);
+  CHECK(vec.size() == 10 && vec.capacity() == STATIC_CAP);
+  // crosses from static to dynamic memory
+  vec.append_n(10, counter);
+  CHECK(vec.size() == 20 && vec.capacity() > STATIC_CAP);
+  for (int i = 0; i < 20; i++)
+    {
+      CHECK(vec[i] == i);
+    }
+
+  // a throwing generator keeps only the generated elements
+  vl_vector<int, STATIC_CAP> partial((size_t) 10, 7);
+  int calls = 0;
+  bool thrown = false;
+  try
+    {
+      partial.append_n(20, [&calls] () {
+        if (calls == 3)
+          {
+            throw std::runtime_error("generator");
+          }
+        return calls++;
+      });
+    }
+  catch (const std::runtime_error&)
+    {
+      thrown = true;
+    }
+  CHECK(thrown && partial.size() == 13 && partial.capacity() == STATIC_CAP);
+  CHECK(partial[9] == 7 && partial[10] == 0 && partial[12] == 2);
+}
+
+void test_read_from_pipe ()
+{
+  char text[101];
+  for (int i = 0; i < 100; i++)
+    {
+      text[i] = (char) ('a' + i % 26);
+    }
+  text[100] = '\0';
+  int fd = pipe_with(text);
+  vl_vector<char, STATIC_CAP> vec;
+  vec.push_back('!');
+  CHECK(vec.read_from(fd, 5) == 5 && vec.size() == 6);
+  CHECK(vec.capacity() == STATIC_CAP);
+  // crosses from static to dynamic memory with a single readv
+  CHECK(vec.read_from(fd, 1000) == 95 && vec.size() == 101);
+  CHECK(vec.capacity() > STATIC_CAP);
+  CHECK(vec[0] == '!' && memcmp(vec.data() + 1, text, 100) == 0);
+  // EOF keeps the vector and the reserve of the previous read
+  size_t cap = vec.capacity();
+  CHECK(vec.read_from(fd, 10) == 0 && vec.size() == 101);
+  CHECK(vec.capacity() == cap);
+  close(fd);
+}
+
+void test_read_from_full_static ()
+{
+  int fd = pipe_with("");
+  vl_vector<char, STATIC_CAP> vec((size_t) STATIC_CAP, 'x');
+  CHECK(vec.read_from(fd, 100) == 0);
+  CHECK(vec.size() == STATIC_CAP && vec.capacity() == STATIC_CAP);
+  close(fd);
+
+  fd = pipe_with("abc");
+  CHECK(vec.read_from(fd, 100) == 3 && vec.size() == STATIC_CAP + 3);
+  CHECK(vec[0] == 'x' && vec[STATIC_CAP - 1] == 'x');
+  CHECK(vec[STATIC_CAP] == 'a' && vec[STATIC_CAP + 2] == 'c');
+  close(fd);
+}
+
+void test_pread_from ()
+{
+  char path[] = "/tmp/vl_vector_testXXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  const char * text = "0123456789abcdefghijklmnopqrstuvwxyz";
+  CHECK(write(fd, text, strlen(text)) == (ssize_t) strlen(text));
+  vl_vector<char, STATIC_CAP> vec;
+  CHECK(vec.pread_from(fd, 10, 0) == 10 && vec[0] == '0');
+  CHECK(vec.pread_from(fd, 100, 10) == 26 && vec.size() == 36);
+  CHECK(memcmp(vec.data(), text, 36) == 0);
+  // pread does not move the file offset, which is at the end of the file
+  CHECK(vec.read_from(fd, 10) == 0);
+  close(fd);
+  unlink(path);
+}
+
+void test_read_from_bad_fd ()
+{
+  vl_vector<char, STATIC_CAP> vec((size_t) 5, 'x');
+  CHECK(vec.read_from(-1, 100) == -1);
+  CHECK(vec.size() == 5 && vec.capacity() == STATIC_CAP);
+  vl_vector<char, STATIC_CAP> big((size_t) 40, 'y');
+  CHECK(big.read_from(-1, 10) == -1 && big.size() == 40);
+  CHECK(big.pread_from(-1, 10, 0) == -1 && big.size() == 40);
+  for (int i = 0; i < 40; i++)
+    {
+      CHECK(big[i] == 'y');
+    }
+}
+
+void test_read_from_growth ()
+{
+  char text[1000];
+  memset(text, 'z', sizeof(text));
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  CHECK(write(fds[1], text, sizeof(text)) == (ssize_t) sizeof(text));
+  close(fds[1]);
+  vl_vector<char, STATIC_CAP> vec;
+  size_t reallocs = 0;
+  size_t cap = vec.capacity();
+  while (vec.read_from(fds[0], 10) > 0)
+    {
+      if (vec.capacity() != cap)
+        {
+          reallocs++;
+          cap = vec.capacity();
+        }
+    }
+  // the capacity at least doubles on every growth
+  CHECK(vec.size() == sizeof(text) && reallocs <= 7);
+  CHECK(memcmp(vec.data(), text, sizeof(text)) == 0);
+  close(fds[0]);
+}
+
+void test_read_from_huge_count ()
+{
+  int fd = pipe_with("abc");
+  vl_vector<char, STATIC_CAP> vec((size_t) 1, 'x');
+  // the count is clamped to SSIZE_MAX, which is too much with one element
+  bool thrown = false;
+  try
+    {
+      vec.read_from(fd, SIZE_MAX);
+    }
+  catch (const std::length_error&)
+    {
+      thrown = true;
+    }
+  CHECK(thrown && vec.size() == 1 && vec.capacity() == STATIC_CAP);
+  close(fd);
+}
+
+int main ()
+{
+  test_append_uninitialized();
+  test_append_n();
+  test_read_from_pipe();
+  test_read_from_full_static();
+  test_pread_from();
+  test_read_from_bad_fd();
+  test_read_from_growth();
+  test_read_from_huge_count();
+  printf("all tests passed\n");
+  return EXIT_SUCCESS;
+}
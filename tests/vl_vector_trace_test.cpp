@@ -0,0 +1,229 @@
+// tests for the tracing hooks of vl_vector.
+// build: g++ -std=c++11 -pthread tests/vl_vector_trace_test.cpp && ./a.out
+#include "../vl_vector_trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <atomic>
+
+#define STATIC_CAP 4
+
+// like assert, but always evaluates its argument, also with NDEBUG
+#define CHECK(cond) \
+  do \
+    { \
+      if (!(cond)) \
+        { \
+          fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                  #cond); \
+          exit(EXIT_FAILURE); \
+        } \
+    } \
+  while (0)
+
+typedef vl_vector_tracer<64> tracer;
+typedef vl_vector<int, STATIC_CAP, tracer> traced_vector;
+
+// checks the fields of one record of the calling thread
+/// \param index index of the record
+/// \param event the expected event
+/// \param elements the expected number of elements
+/// \param bytes the expected number of bytes
+void check_record (size_t index, vl_vector_event event, size_t elements,
+                   size_t bytes)
+{
+  vl_trace_record rec = tracer::record(index);
+  CHECK(rec.event == event);
+  CHECK(rec.elements == elements);
+  CHECK(rec.bytes == bytes);
+  CHECK(rec.end >= rec.start);
+}
+
+void test_push_and_pop ()
+{
+  tracer::clear();
+  traced_vector vec;
+  for (int i = 0; i < STATIC_CAP; i++)
+    {
+      vec.push_back(i);
+    }
+  CHECK(tracer::size() == 0);
+  vec.push_back(STATIC_CAP);
+  CHECK(tracer::size() == 1);
+  check_record(0, vl_vector_event::TO_DYNAMIC, 4, 7 * sizeof(int));
+  while (vec.size() < 7)
+    {
+      vec.push_back(0);
+    }
+  CHECK(tracer::size() == 1);
+  vec.push_back(0);
+  CHECK(tracer::size() == 2);
+  check_record(1, vl_vector_event::REALLOC, 7, 12 * sizeof(int));
+  while (vec.size() > STATIC_CAP + 1)
+    {
+      vec.pop_back();
+    }
+  CHECK(tracer::size() == 2);
+  vec.pop_back();
+  CHECK(tracer::size() == 3);
+  check_record(2, vl_vector_event::TO_STATIC, 4, 4 * sizeof(int));
+}
+
+void test_insert_and_erase ()
+{
+  tracer::clear();
+  traced_vector vec;
+  vec.push_back(1);
+  vec.push_back(2);
+  // the elements count is the number of elements that were moved
+  vec.insert(vec.begin(), 0);
+  CHECK(tracer::size() == 1);
+  check_record(0, vl_vector_event::SHIFT, 2, 2 * sizeof(int));
+
+  int values[] = {7, 8};
+  vec.insert(vec.begin() + 1, values, values + 2);
+  CHECK(vec.size() == 5 && tracer::size() == 3);
+  check_record(1, vl_vector_event::TO_DYNAMIC, 3, 7 * sizeof(int));
+  check_record(2, vl_vector_event::SHIFT, 2, 2 * sizeof(int));
+  CHECK(vec[0] == 0 && vec[1] == 7 && vec[2] == 8 && vec[3] == 1);
+
+  // a range insert in dynamic memory moves only the elements after position
+  vec.insert(vec.begin() + 4, values, values + 1);
+  CHECK(vec.size() == 6 && tracer::size() == 4);
+  check_record(3, vl_vector_event::SHIFT, 1, sizeof(int));
+  CHECK(vec[4] == 7 && vec[5] == 2);
+  vec.erase(vec.begin() + 4);
+
+  vec.erase(vec.begin() + 1);
+  CHECK(vec.size() == 4 && tracer::size() == 7);
+  check_record(5, vl_vector_event::SHIFT, 3, 3 * sizeof(int));
+  check_record(6, vl_vector_event::TO_STATIC, 4, 4 * sizeof(int));
+  CHECK(vec[0] == 0 && vec[1] == 8 && vec[2] == 1 && vec[3] == 2);
+}
+
+void test_read_from_full_static ()
+{
+  typedef vl_vector_tracer<16> byte_tracer;
+  byte_tracer::clear();
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  close(fds[1]);
+  vl_vector<char, STATIC_CAP, byte_tracer> vec((size_t) STATIC_CAP, 'x');
+  // EOF on a full static vector does not move to dynamic memory
+  CHECK(vec.read_from(fds[0], 100) == 0);
+  CHECK(byte_tracer::size() == 0);
+  close(fds[0]);
+}
+
+void test_sampling ()
+{
+  typedef vl_vector_tracer<16, 2> sampled_tracer;
+  vl_vector<int, STATIC_CAP, sampled_tracer> vec((size_t) STATIC_CAP, 0);
+  for (int i = 0; i < 3; i++)
+    {
+      vec.push_back(0);
+      vec.pop_back();
+    }
+  // 6 events, only every second one is recorded
+  CHECK(sampled_tracer::size() == 3);
+  for (size_t i = 0; i < 3; i++)
+    {
+      CHECK(sampled_tracer::record(i).event == vl_vector_event::TO_DYNAMIC);
+    }
+}
+
+void test_ring_overwrite ()
+{
+  typedef vl_vector_tracer<2> small_tracer;
+  vl_vector<int, STATIC_CAP, small_tracer> vec((size_t) STATIC_CAP, 0);
+  vec.push_back(0);
+  vec.pop_back();
+  vec.push_back(0);
+  CHECK(small_tracer::size() == 2);
+  // the oldest record was overwritten
+  CHECK(small_tracer::record(0).event == vl_vector_event::TO_STATIC);
+  CHECK(small_tracer::record(1).event == vl_vector_event::TO_DYNAMIC);
+}
+
+void test_chrome_trace_all_threads ()
+{
+  typedef vl_vector_tracer<16> shared_tracer;
+  vl_vector<int, STATIC_CAP, shared_tracer> vec((size_t) STATIC_CAP, 0);
+  vec.push_back(0);
+  long other_tid = 0;
+  std::thread other([&other_tid] () {
+    other_tid = (long) syscall(SYS_gettid);
+    vl_vector<int, STATIC_CAP, shared_tracer> local((size_t) STATIC_CAP, 0);
+    local.push_back(0);
+    local.pop_back();
+  });
+  other.join();
+
+  std::ostringstream out;
+  CHECK(shared_tracer::write_chrome_trace(out) == 3);
+  std::string json = out.str();
+  CHECK(json.find("{\"traceEvents\":[") == 0);
+  std::string own = "\"tid\":" + std::to_string((long) syscall(SYS_gettid));
+  std::string others = "\"tid\":" + std::to_string(other_tid);
+  CHECK(json.find(own) != std::string::npos);
+  CHECK(json.find(others) != std::string::npos);
+  CHECK(json.find("\"name\":\"to_static\"") != std::string::npos);
+  CHECK(json.find("\"args\":{\"elements\":4,\"bytes\":28}")
+         != std::string::npos);
+}
+
+void test_ring_reuse ()
+{
+  typedef vl_vector_tracer<4> reused_tracer;
+  for (int i = 0; i < 20; i++)
+    {
+      std::thread worker([] () {
+        vl_vector<int, STATIC_CAP, reused_tracer> local((size_t) STATIC_CAP,
+                                                        0);
+        local.push_back(0);
+      });
+      worker.join();
+    }
+  // every thread took the ring of the thread before it, so only the last
+  // 4 records are kept
+  std::ostringstream out;
+  CHECK(reused_tracer::write_chrome_trace(out) == 4);
+}
+
+void test_dump_while_tracing ()
+{
+  typedef vl_vector_tracer<8> busy_tracer;
+  std::atomic<bool> done(false);
+  std::thread worker([&done] () {
+    vl_vector<int, STATIC_CAP, busy_tracer> local((size_t) STATIC_CAP, 0);
+    while (!done.load())
+      {
+        local.push_back(0);
+        local.pop_back();
+      }
+  });
+  for (int i = 0; i < 200; i++)
+    {
+      std::ostringstream out;
+      CHECK(busy_tracer::write_chrome_trace(out) <= 8);
+      CHECK(out.str().find("\n]}") != std::string::npos);
+    }
+  done.store(true);
+  worker.join();
+}
+
+int main ()
+{
+  test_push_and_pop();
+  test_insert_and_erase();
+  test_read_from_full_static();
+  test_sampling();
+  test_ring_overwrite();
+  test_chrome_trace_all_threads();
+  test_ring_reuse();
+  test_dump_while_tracing();
+  printf("all tests passed\n");
+  return EXIT_SUCCESS;
+}
@@ -1,12 +1,54 @@
 #ifndef _VL_VECTOR_H_
 #define _VL_VECTOR_H_
 #include <exception>
+#include <stdexcept>
+#include <new>
+#include <cstdlib>
+#include <climits>
+#include <cstdint>
 #include <iterator>
+#include <algorithm>
 #include <cassert>
+#include <type_traits>
+// the file descriptor functions (read_from, pread_from) need POSIX, they can
+// be turned off by defining VL_VECTOR_NO_FD_IO
+#if !defined(VL_VECTOR_NO_FD_IO) && (defined(__unix__) || defined(__APPLE__))
+#define VL_VECTOR_FD_IO
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
 #define DEFAULT_CAPACITY 16
-#endif //_VL_VECTOR_H_
-size_t cap_max (int static_cap, int cur_size, int elem_add);
-template <class T, int StaticCapacity = DEFAULT_CAPACITY>
+inline size_t cap_max (int static_cap, int cur_size, int elem_add);
+
+/// the costly operations of a vl_vector that are reported to the hooks
+enum class vl_vector_event
+{
+  // moving dynamic memory to a bigger dynamic memory
+  REALLOC,
+  // moving from static memory to dynamic memory
+  TO_DYNAMIC,
+  // moving from dynamic memory back to static memory
+  TO_STATIC,
+  // shifting elements to make room for inserted elements or to close the
+  // gap of erased elements
+  SHIFT
+};
+
+/// the default hooks of a vl_vector, does nothing.
+/// a hooks class has a scope type, that is constructed right before a costly
+/// operation and destroyed right after it, with the event, the number of
+/// elements that are moved and the number of bytes that are allocated (for
+/// REALLOC and TO_DYNAMIC) or moved (for TO_STATIC and SHIFT)
+struct vl_vector_no_hooks
+{
+  struct scope
+  {
+    scope (vl_vector_event, size_t, size_t) {}
+  };
+};
+
+template <class T, int StaticCapacity = DEFAULT_CAPACITY,
+    class Hooks = vl_vector_no_hooks>
 class vl_vector
 {
  public:
@@ -61,7 +103,7 @@ class vl_vector
     _size = other_vector._size;
     if (other_vector._size > StaticCapacity)
       {
-        _dynamic_memory = new T[other_vector._capacity];
+        _dynamic_memory = _allocate(other_vector._capacity);
         for (size_t i = 0; i <other_vector._size; i++)
           {
             _dynamic_memory[i] = other_vector._dynamic_memory[i];
@@ -86,7 +128,7 @@ class vl_vector
     if (_size > StaticCapacity)
       {
         _capacity = cap_max(StaticCapacity, _size, 0);
-        _dynamic_memory = new T[_capacity];
+        _dynamic_memory = _allocate(_capacity);
         for (size_t i = 0; i <_size; i++)
           {
             _dynamic_memory[i] = *first;
@@ -120,7 +162,7 @@ class vl_vector
     else
       {
         _capacity = cap_max(StaticCapacity, _size, 0);
-        _dynamic_memory = new T[_capacity];
+        _dynamic_memory = _allocate(_capacity);
         for (size_t i = 0; i <_size; i++)
           {
             _dynamic_memory[i] = v;
@@ -132,7 +174,7 @@ class vl_vector
   {
     if (_size > StaticCapacity)
       {
-        delete[] _dynamic_memory;
+        _release(_dynamic_memory);
       }
   }
 
@@ -204,15 +246,17 @@ class vl_vector
         // making realloc if the capacity needed is higher than the current
         else
           {
+            typename Hooks::scope trace(vl_vector_event::REALLOC, _size,
+                                        new_cap * sizeof(T));
             _capacity = new_cap;
             T * temp_memory;
             temp_memory = _dynamic_memory;
-            _dynamic_memory = new T[new_cap];
+            _dynamic_memory = _allocate(new_cap);
             for (size_t i = 0; i < _size; i++)
               {
                 _dynamic_memory[i] = temp_memory[i];
               }
-            delete[] temp_memory;
+            _release(temp_memory);
             _dynamic_memory[_size] = element;
             _size ++;
           }
@@ -220,7 +264,9 @@ class vl_vector
     //  moving to dynamic memory
     else if(_size == StaticCapacity)
       {
-        _dynamic_memory = new T[new_cap];
+        typename Hooks::scope trace(vl_vector_event::TO_DYNAMIC, _size,
+                                    new_cap * sizeof(T));
+        _dynamic_memory = _allocate(new_cap);
         _capacity = new_cap;
         for (size_t i = 0; i < _size; i++)
           {
@@ -237,6 +283,88 @@ class vl_vector
       }
   }
 
+  /// grows the vector by n elements and returns a pointer to the first of
+  /// them, so the caller can fill the new tail directly.
+  /// throws std::length_error if the new capacity does not fit in a size_t
+  /// \param n number of elements to add to the end of the vector
+  /// \return pointer to the first added element
+  T * append_uninitialized(size_t n)
+  {
+    size_t old_size = _size;
+    size_t new_cap = _grown_capacity(n);
+    size_t new_size = _size + n;
+    if (new_size <= StaticCapacity)
+      {
+        _size = new_size;
+        return _static_memory + old_size;
+      }
+    // also covers moving from static to dynamic memory, since the capacity
+    // of a static vector is StaticCapacity
+    if (new_size > _capacity)
+      {
+        _reserve_dynamic(new_cap);
+      }
+    _size = new_size;
+    return _dynamic_memory + old_size;
+  }
+
+  /// appends n elements to the end of the vector, each one is the result of
+  /// a call to the generator. if the generator throws, the elements that
+  /// were already generated are kept, the rest are removed and the
+  /// exception is rethrown
+  /// \tparam Generator callable that takes no arguments and returns a T
+  /// \param n number of elements to add
+  /// \param generator the generator of the new elements
+  /// \return iterator to the first element that was added
+  template <class Generator>
+  iterator append_n(size_t n, Generator generator)
+  {
+    T * tail = append_uninitialized(n);
+    size_t i = 0;
+    try
+      {
+        for (; i < n; i++)
+          {
+            tail[i] = generator();
+          }
+      }
+    catch (...)
+      {
+        _drop_tail(n - i);
+        throw;
+      }
+    return tail;
+  }
+
+#ifdef VL_VECTOR_FD_IO
+  /// reads up to max_count bytes from a file descriptor directly into the
+  /// end of the vector, only for byte vectors.
+  /// max_count also acts as a reserve: the capacity is grown to hold
+  /// max_count more bytes before the read and is kept after a short read,
+  /// so a loop of reads with the same max_count reallocates only when the
+  /// vector really grows, like a raw read into a malloc'd buffer
+  /// \param fd the file descriptor to read from
+  /// \param max_count max number of bytes to read
+  /// \return number of bytes read, or -1 on error. on error the elements are
+  /// unchanged, but the capacity may already have grown, which invalidates
+  /// iterators and pointers into the vector
+  ssize_t read_from(int fd, size_t max_count)
+  {
+    return _read_tail(fd, max_count, 0, false);
+  }
+
+  /// same as read_from, but reads from a given offset in the file without
+  /// changing the file offset
+  /// \param fd the file descriptor to read from
+  /// \param max_count max number of bytes to read
+  /// \param offset the offset in the file to read from
+  /// \return number of bytes read, or -1 on error, see read_from
+  ssize_t pread_from(int fd, size_t max_count, off_t offset)
+  {
+    return _read_tail(fd, max_count, offset, true);
+  }
+#endif //VL_VECTOR_FD_IO
+
   // pops an element from the end of the vector
   void pop_back()
   {
@@ -246,11 +374,13 @@ class vl_vector
       }
     if (_size - 1 == StaticCapacity)
       {
+        typename Hooks::scope trace(vl_vector_event::TO_STATIC, _size - 1,
+                                    (_size - 1) * sizeof(T));
         for (size_t i = 0; i < _size - 1; i++)
           {
             _static_memory[i] = _dynamic_memory[i];
           }
-        delete[] _dynamic_memory;
+        _release(_dynamic_memory);
         _capacity = StaticCapacity;
       }
     _size --;
@@ -261,7 +391,7 @@ class vl_vector
   {
     if (_size > StaticCapacity)
       {
-        delete[] _dynamic_memory;
+        _release(_dynamic_memory);
       }
     _size = 0;
     _capacity = StaticCapacity;
@@ -281,41 +411,55 @@ class vl_vector
       {
         if (_size < _capacity)
           {
-            iterator end_iter = end();
-            while (end_iter >= position)
-              {
-                *end_iter = *(end_iter - 1);
-                end_iter --;
-              }
+            {
+              typename Hooks::scope trace(vl_vector_event::SHIFT,
+                                          distance_from_beg,
+                                          distance_from_beg * sizeof(T));
+              iterator end_iter = end();
+              while (end_iter > position)
+                {
+                  *end_iter = *(end_iter - 1);
+                  end_iter --;
+                }
+            }
             *non_const_position = element;
             _size ++;
           }
         else
           {
             size_t distance_it = std::distance(begin(), non_const_position);
-            _capacity = new_cap;
-            T * temp_memory;
-            temp_memory = new T[_size];
-            for (size_t k = 0; k < _size; k++)
-              {
-                temp_memory[k] = _dynamic_memory[k];
-              }
-            delete[] _dynamic_memory;
-            _dynamic_memory = new T[new_cap];
-            for (size_t i = 0; i < _size; i++)
-              {
-                _dynamic_memory[i] = temp_memory[i];
-              }
-            delete[] temp_memory;
-            iterator end_iter = end();
-            int l = 0;
+            {
+              typename Hooks::scope trace(vl_vector_event::REALLOC, _size,
+                                          new_cap * sizeof(T));
+              _capacity = new_cap;
+              T * temp_memory;
+              temp_memory = new T[_size];
+              for (size_t k = 0; k < _size; k++)
+                {
+                  temp_memory[k] = _dynamic_memory[k];
+                }
+              _release(_dynamic_memory);
+              _dynamic_memory = _allocate(new_cap);
+              for (size_t i = 0; i < _size; i++)
+                {
+                  _dynamic_memory[i] = temp_memory[i];
+                }
+              delete[] temp_memory;
+            }
+            {
+              typename Hooks::scope trace(vl_vector_event::SHIFT,
+                                          distance_from_beg,
+                                          distance_from_beg * sizeof(T));
+              iterator end_iter = end();
+              int l = 0;
 
-            for (size_t j = 0; j < distance_from_beg; j++)
-              {
-                *end_iter = *(end_iter - 1);
-                end_iter --;
-                l++;
-              }
+              for (size_t j = 0; j < distance_from_beg; j++)
+                {
+                  *end_iter = *(end_iter - 1);
+                  end_iter --;
+                  l++;
+                }
+            }
             non_const_position = (begin() + distance_it);
             *non_const_position = element;
             _size ++;
@@ -323,31 +467,45 @@ class vl_vector
       }
     else if(_size == StaticCapacity)
       {
-        _dynamic_memory = new T[new_cap];
-        _capacity = new_cap;
-        for (size_t i = 0; i < _size; i++)
-          {
-            _dynamic_memory[i] = _static_memory[i];
-          }
+        {
+          typename Hooks::scope trace(vl_vector_event::TO_DYNAMIC, _size,
+                                      new_cap * sizeof(T));
+          _dynamic_memory = _allocate(new_cap);
+          _capacity = new_cap;
+          for (size_t i = 0; i < _size; i++)
+            {
+              _dynamic_memory[i] = _static_memory[i];
+            }
+        }
         size_t distance_it = std::distance(begin(), non_const_position);
         _size ++;
-        iterator end_iter = end() - 1;
-        for (size_t j = 0; j < distance_from_beg; j++)
-          {
-            *end_iter = *(end_iter - 1);
-            end_iter --;
-          }
+        {
+          typename Hooks::scope trace(vl_vector_event::SHIFT,
+                                      distance_from_beg,
+                                      distance_from_beg * sizeof(T));
+          iterator end_iter = end() - 1;
+          for (size_t j = 0; j < distance_from_beg; j++)
+            {
+              *end_iter = *(end_iter - 1);
+              end_iter --;
+            }
+        }
         non_const_position = (begin() + distance_it);
         *non_const_position = element;
       }
     else if (_size < StaticCapacity)
       {
-        iterator end_iter = end();
-        while (end_iter >= position)
-          {
-            *end_iter = *(end_iter - 1);
-            end_iter --;
-          }
+        {
+          typename Hooks::scope trace(vl_vector_event::SHIFT,
+                                      distance_from_beg,
+                                      distance_from_beg * sizeof(T));
+          iterator end_iter = end();
+          while (end_iter > position)
+            {
+              *end_iter = *(end_iter - 1);
+              end_iter --;
+            }
+        }
         *non_const_position = element;
         _size ++;
       }
@@ -372,6 +530,8 @@ class vl_vector
       {
         if (elements_num + _size > _capacity)
           {
+            typename Hooks::scope trace(vl_vector_event::REALLOC, _size,
+                                        new_cap * sizeof(T));
             _capacity = new_cap;
             T * temp_memory;
             temp_memory = new T[_size];
@@ -379,8 +539,8 @@ class vl_vector
               {
                 temp_memory[k] = _dynamic_memory[k];
               }
-            delete[] _dynamic_memory;
-            _dynamic_memory = new T[new_cap];
+            _release(_dynamic_memory);
+            _dynamic_memory = _allocate(new_cap);
             for (size_t i = 0; i < _size; i++)
               {
                 _dynamic_memory[i] = temp_memory[i];
@@ -389,11 +549,17 @@ class vl_vector
           }
         iterator end_iter = end() + elements_num;
         non_const_position = (begin() + distance_it);
-        for (size_t j = 0; j < _size; j++)
-          {
-            *(end_iter - 1) = *(end_iter - elements_num - 1);
-            end_iter --;
-          }
+        {
+          // only the elements from position to the end are moved
+          size_t shifted = _size - distance_it;
+          typename Hooks::scope trace(vl_vector_event::SHIFT, shifted,
+                                      shifted * sizeof(T));
+          for (size_t j = 0; j < shifted; j++)
+            {
+              *(end_iter - 1) = *(end_iter - elements_num - 1);
+              end_iter --;
+            }
+        }
         for (size_t i = 0; i < elements_num; i++)
           {
             _dynamic_memory[i + std::distance(begin(),
@@ -405,20 +571,30 @@ class vl_vector
       }
     else if(_size <= StaticCapacity && (_size + elements_num) > StaticCapacity)
       {
-        _dynamic_memory = new T[new_cap];
-        _capacity = new_cap;
-        for (size_t i = 0; i < _size; i++)
-          {
-            _dynamic_memory[i] = _static_memory[i];
-          }
+        {
+          typename Hooks::scope trace(vl_vector_event::TO_DYNAMIC, _size,
+                                      new_cap * sizeof(T));
+          _dynamic_memory = _allocate(new_cap);
+          _capacity = new_cap;
+          for (size_t i = 0; i < _size; i++)
+            {
+              _dynamic_memory[i] = _static_memory[i];
+            }
+        }
         _size += elements_num;
         iterator end_iter = end();
         non_const_position = (begin() + distance_it);
-        for (size_t j = 0; j < _size - elements_num; j++)
-          {
-            *(end_iter - 1) = *(end_iter - elements_num - 1);
-            end_iter --;
-          }
+        {
+          // only the elements from position to the end are moved
+          size_t shifted = _size - elements_num - distance_it;
+          typename Hooks::scope trace(vl_vector_event::SHIFT, shifted,
+                                      shifted * sizeof(T));
+          for (size_t j = 0; j < shifted; j++)
+            {
+              *(end_iter - 1) = *(end_iter - elements_num - 1);
+              end_iter --;
+            }
+        }
         for (size_t i = 0; i < elements_num; i++)
           {
             _dynamic_memory[i + std::distance(begin(),
@@ -430,11 +606,16 @@ class vl_vector
     else if (elements_num + _size <= StaticCapacity)
       {
         iterator end_iter = end() + elements_num;
-        while (end_iter >= non_const_position + elements_num)
-          {
-            *(end_iter - 1) = *(end_iter - elements_num - 1);
-            end_iter --;
-          }
+        {
+          size_t shifted = _size - distance_it;
+          typename Hooks::scope trace(vl_vector_event::SHIFT, shifted,
+                                      shifted * sizeof(T));
+          while (end_iter > non_const_position + elements_num)
+            {
+              *(end_iter - 1) = *(end_iter - elements_num - 1);
+              end_iter --;
+            }
+        }
         for (size_t i = 0; i < elements_num; i++)
           {
             _static_memory[i + std::distance(begin(),
@@ -456,32 +637,44 @@ class vl_vector
     size_t dist = std::distance(begin(), non_const_position);
     if (_size > StaticCapacity)
       {
-        iterator new_pos_iter = non_const_position;
-        while (new_pos_iter <= end () - 1)
-          {
-            *new_pos_iter = *(new_pos_iter + 1);
-            new_pos_iter++;
-          }
+        {
+          size_t shifted = _size - dist - 1;
+          typename Hooks::scope trace(vl_vector_event::SHIFT, shifted,
+                                      shifted * sizeof(T));
+          iterator new_pos_iter = non_const_position;
+          while (new_pos_iter < end () - 1)
+            {
+              *new_pos_iter = *(new_pos_iter + 1);
+              new_pos_iter++;
+            }
+        }
         if (_size == StaticCapacity + 1)
           {
+            typename Hooks::scope trace(vl_vector_event::TO_STATIC,
+                                        _size - 1, (_size - 1) * sizeof(T));
             _capacity = StaticCapacity;
             for (size_t i = 0; i < _size - 1; i++)
               {
                 _static_memory[i] = _dynamic_memory[i];
               }
-            delete[] _dynamic_memory;
+            _release(_dynamic_memory);
           }
         _size --;
         non_const_position = begin() + dist;
       }
     else if (_size <= StaticCapacity)
       {
-        iterator new_pos_iter = non_const_position;
-        while (new_pos_iter <= end() - 1)
-          {
-            *new_pos_iter = *(new_pos_iter + 1);
-            new_pos_iter ++;
-          }
+        {
+          size_t shifted = _size - dist - 1;
+          typename Hooks::scope trace(vl_vector_event::SHIFT, shifted,
+                                      shifted * sizeof(T));
+          iterator new_pos_iter = non_const_position;
+          while (new_pos_iter < end() - 1)
+            {
+              *new_pos_iter = *(new_pos_iter + 1);
+              new_pos_iter ++;
+            }
+        }
         _size --;
       }
     return non_const_position;
@@ -501,17 +694,24 @@ class vl_vector
     size_t end_dist = std::distance(begin(), end());
     if (_size > StaticCapacity && _size - dist < StaticCapacity)
       {
-        for (size_t i = 0; i < end_dist - (begin_dist + dist); i++)
-          {
-            *non_first = *(non_first + dist);
-            non_first++;
-          }
+        {
+          size_t shifted = end_dist - (begin_dist + dist);
+          typename Hooks::scope trace(vl_vector_event::SHIFT, shifted,
+                                      shifted * sizeof(T));
+          for (size_t i = 0; i < shifted; i++)
+            {
+              *non_first = *(non_first + dist);
+              non_first++;
+            }
+        }
+        typename Hooks::scope trace(vl_vector_event::TO_STATIC, _size - dist,
+                                    (_size - dist) * sizeof(T));
         _capacity = StaticCapacity;
         for (size_t i = 0; i < _size - dist; i++)
           {
             _static_memory[i] = _dynamic_memory[i];
           }
-        delete[] _dynamic_memory;
+        _release(_dynamic_memory);
         _size = _size - dist;
       }
     else
@@ -629,11 +829,11 @@ class vl_vector
           {
             if (_size > StaticCapacity)
               {
-                delete[] _dynamic_memory;
+                _release(_dynamic_memory);
               }
             _capacity = other_vector._capacity;
             _size = other_vector._size;
-            _dynamic_memory = new T[other_vector._capacity];
+            _dynamic_memory = _allocate(other_vector._capacity);
             for (size_t i = 0; i <other_vector._size; i++)
               {
                 _dynamic_memory[i] = other_vector._dynamic_memory[i];
@@ -642,7 +842,7 @@ class vl_vector
         else if (other_vector._size <= StaticCapacity &&
         _size > StaticCapacity)
           {
-            delete[] _dynamic_memory;
+            _release(_dynamic_memory);
             _capacity = other_vector._capacity;
             _size = other_vector._size;
             for (size_t i = 0; i < other_vector._size; i++)
@@ -665,6 +865,180 @@ class vl_vector
   }
 
  private:
+  /// allocates dynamic memory for a given number of elements. trivial types
+  /// use malloc, so that _reserve_dynamic can grow them with realloc
+  /// \param count number of elements
+  /// \return pointer to the new memory
+  static T * _allocate(size_t count)
+  {
+    if (std::is_trivial<T>::value)
+      {
+        void * memory = std::malloc(count * sizeof(T));
+        if (memory == nullptr)
+          {
+            throw std::bad_alloc();
+          }
+        return static_cast<T *>(memory);
+      }
+    return new T[count];
+  }
+
+  /// frees dynamic memory that was allocated by _allocate
+  /// \param memory the memory to free
+  static void _release(T * memory)
+  {
+    if (std::is_trivial<T>::value)
+      {
+        std::free(memory);
+      }
+    else
+      {
+        delete[] memory;
+      }
+  }
+
+  /// moves the elements into a new dynamic memory with a given capacity
+  /// \param new_cap the capacity of the new memory, bigger than StaticCapacity
+  void _reserve_dynamic(size_t new_cap)
+  {
+    vl_vector_event event = (_size > StaticCapacity) ?
+        vl_vector_event::REALLOC : vl_vector_event::TO_DYNAMIC;
+    typename Hooks::scope trace(event, _size, new_cap * sizeof(T));
+    // realloc can often grow the memory in place, or remap its pages
+    // instead of copying them
+    if (std::is_trivial<T>::value && _size > StaticCapacity)
+      {
+        void * memory = std::realloc(_dynamic_memory, new_cap * sizeof(T));
+        if (memory == nullptr)
+          {
+            throw std::bad_alloc();
+          }
+        _dynamic_memory = static_cast<T *>(memory);
+        _capacity = new_cap;
+        return;
+      }
+    T * new_memory = _allocate(new_cap);
+    const T * old_memory = begin();
+    // std::copy becomes a memmove for trivially copyable types
+    std::copy(old_memory, old_memory + _size, new_memory);
+    if (_size > StaticCapacity)
+      {
+        _release(_dynamic_memory);
+      }
+    _dynamic_memory = new_memory;
+    _capacity = new_cap;
+  }
+
+  /// calculates the capacity that is needed to add n elements, at least
+  /// twice the current capacity. throws std::length_error if the capacity
+  /// is more than PTRDIFF_MAX bytes
+  /// \param n number of elements that will be added
+  /// \return the new capacity of the vector
+  size_t _grown_capacity(size_t n) const
+  {
+    if (n > SIZE_MAX - _size)
+      {
+        throw std::length_error("length error");
+      }
+    size_t needed = _size + n;
+    if (needed <= StaticCapacity)
+      {
+        return StaticCapacity;
+      }
+    size_t max_cap = PTRDIFF_MAX / sizeof(T);
+    if (needed > max_cap)
+      {
+        throw std::length_error("length error");
+      }
+    // grows geometrically from the current capacity, so a loop of small
+    // appends copies every element a constant number of times
+    size_t doubled = (_capacity > max_cap / 2) ? max_cap : 2 * _capacity;
+    return (doubled > needed) ? doubled : needed;
+  }
+
+  /// removes count elements from the end of the vector, moving back to
+  /// static memory if needed
+  /// \param count number of elements to remove
+  void _drop_tail(size_t count)
+  {
+    size_t new_size = _size - count;
+    if (_size > StaticCapacity && new_size <= StaticCapacity)
+      {
+        typename Hooks::scope trace(vl_vector_event::TO_STATIC, new_size,
+                                    new_size * sizeof(T));
+        for (size_t i = 0; i < new_size; i++)
+          {
+            _static_memory[i] = _dynamic_memory[i];
+          }
+        _release(_dynamic_memory);
+        _capacity = StaticCapacity;
+      }
+    _size = new_size;
+  }
+
+#ifdef VL_VECTOR_FD_IO
+  /// reads up to max_count bytes into the end of the vector. when the read
+  /// may cross from static to dynamic memory, a single readv fills the rest
+  /// of the static memory and the matching part of the new dynamic memory,
+  /// so the static elements are copied only if the read crossed over
+  /// \param fd the file descriptor to read from
+  /// \param max_count max number of bytes to read
+  /// \param offset the offset in the file, used only if positional is true
+  /// \param positional true to use pread/preadv, false to use read/readv
+  /// \return number of bytes read, or -1 on error
+  ssize_t _read_tail(int fd, size_t max_count, off_t offset, bool positional)
+  {
+    static_assert(sizeof(T) == 1 && std::is_trivially_copyable<T>::value,
+                  "reading from a file descriptor needs a byte vector");
+    if (max_count == 0)
+      {
+        return 0;
+      }
+    if (max_count > SSIZE_MAX)
+      {
+        max_count = SSIZE_MAX;
+      }
+    size_t new_cap = _grown_capacity(max_count);
+    size_t new_size = _size + max_count;
+    if (_size <= StaticCapacity && new_size > StaticCapacity)
+      {
+        T * heap_memory = _allocate(new_cap);
+        struct iovec iov[2];
+        iov[0].iov_base = _static_memory + _size;
+        iov[0].iov_len = StaticCapacity - _size;
+        iov[1].iov_base = heap_memory + StaticCapacity;
+        iov[1].iov_len = new_size - StaticCapacity;
+        ssize_t got = positional ? preadv(fd, iov, 2, offset)
+                                 : readv(fd, iov, 2);
+        if (got < 0 || _size + got <= StaticCapacity)
+          {
+            _release(heap_memory);
+            if (got > 0)
+              {
+                _size += got;
+              }
+            return got;
+          }
+        // the read crossed into the dynamic memory
+        typename Hooks::scope trace(vl_vector_event::TO_DYNAMIC,
+                                    StaticCapacity, new_cap * sizeof(T));
+        for (size_t i = 0; i < StaticCapacity; i++)
+          {
+            heap_memory[i] = _static_memory[i];
+          }
+        _dynamic_memory = heap_memory;
+        _capacity = new_cap;
+        _size += got;
+        return got;
+      }
+    T * tail = append_uninitialized(max_count);
+    ssize_t got = positional ? pread(fd, tail, max_count, offset)
+                             : read(fd, tail, max_count);
+    _drop_tail(got < 0 ? max_count : max_count - got);
+    return got;
+  }
+#endif //VL_VECTOR_FD_IO
+
   T _static_memory[StaticCapacity];
   T * _dynamic_memory;
   size_t _size;
@@ -676,7 +1050,7 @@ class vl_vector
 /// \param cur_size the current size of the vector
 /// \param elem_add numbers of elements that will be added/removed
 /// \return the new capacity of the vector
-size_t cap_max (int static_cap, int cur_size, int elem_add)
+inline size_t cap_max (int static_cap, int cur_size, int elem_add)
 {
   if (cur_size + elem_add <= static_cap)
     {
@@ -684,3 +1058,4 @@ size_t cap_max (int static_cap, int cur_size, int elem_add)
     }
   return (((3 * (cur_size + elem_add)) / 2));
 }
+#endif //_VL_VECTOR_H_
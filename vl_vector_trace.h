@@ -0,0 +1,292 @@
+#ifndef _VL_VECTOR_TRACE_H_
+#define _VL_VECTOR_TRACE_H_
+#include <ostream>
+#include <iomanip>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+#ifdef VL_TRACE_USE_RDTSC
+#include <x86intrin.h>
+#endif
+#include "vl_vector.cpp"
+#define DEFAULT_TRACE_RING_SIZE 1024
+
+/// one sampled costly operation of a vl_vector
+struct vl_trace_record
+{
+  vl_vector_event event;
+  size_t elements;
+  size_t bytes;
+  uint64_t start;
+  uint64_t end;
+  long tid;
+};
+
+/// hooks for vl_vector that sample the latency of the costly operations into
+/// a per thread ring buffer, the oldest records are overwritten when it is
+/// full. only the owning thread writes to a ring, and every ring is
+/// registered in a lock-free list, so one call can write the records of all
+/// the threads. when a thread exits its ring is marked as free and the next
+/// new thread reuses it, the old records are kept until they are
+/// overwritten.
+/// timestamps are CLOCK_MONOTONIC nanoseconds (the clock of
+/// perf record -k CLOCK_MONOTONIC), or TSC ticks if VL_TRACE_USE_RDTSC is
+/// defined.
+/// usage: vl_vector<char, 16, vl_vector_tracer<>> v;
+/// \tparam RingSize number of records kept per thread
+/// \tparam SampleEvery only one of every SampleEvery events is recorded
+template <size_t RingSize = DEFAULT_TRACE_RING_SIZE, size_t SampleEvery = 1>
+class vl_vector_tracer
+{
+  static_assert(RingSize > 0 && SampleEvery > 0,
+                "RingSize and SampleEvery must be positive");
+
+  // one record in a ring, guarded by a sequence number (a seqlock): while
+  // record number i is written the sequence is 2 * i + 1, after it is
+  // written the sequence is 2 * i + 2
+  struct slot
+  {
+    std::atomic<size_t> sequence;
+    std::atomic<int> event;
+    std::atomic<size_t> elements;
+    std::atomic<size_t> bytes;
+    std::atomic<uint64_t> start;
+    std::atomic<uint64_t> end;
+    std::atomic<long> tid;
+  };
+
+  // the records of one thread
+  struct ring
+  {
+    slot slots[RingSize];
+    std::atomic<size_t> head;
+    std::atomic<bool> in_use;
+    size_t counter;
+    long tid;
+    ring * next;
+  };
+
+ public:
+  class scope
+  {
+   public:
+    scope (vl_vector_event event, size_t elements, size_t bytes)
+        : _ring(local_ring())
+    {
+      _sampled = (_ring.counter++ % SampleEvery == 0);
+      if (_sampled)
+        {
+          _event = event;
+          _elements = elements;
+          _bytes = bytes;
+          _start = now();
+        }
+    }
+    ~scope ()
+    {
+      if (_sampled)
+        {
+          uint64_t end = now();
+          size_t head = _ring.head.load(std::memory_order_relaxed);
+          slot& cur = _ring.slots[head % RingSize];
+          cur.sequence.store(2 * head + 1, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_release);
+          cur.event.store((int) _event, std::memory_order_relaxed);
+          cur.elements.store(_elements, std::memory_order_relaxed);
+          cur.bytes.store(_bytes, std::memory_order_relaxed);
+          cur.start.store(_start, std::memory_order_relaxed);
+          cur.end.store(end, std::memory_order_relaxed);
+          cur.tid.store(_ring.tid, std::memory_order_relaxed);
+          cur.sequence.store(2 * head + 2, std::memory_order_release);
+          _ring.head.store(head + 1, std::memory_order_release);
+        }
+    }
+    scope (const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+   private:
+    ring& _ring;
+    bool _sampled;
+    vl_vector_event _event;
+    size_t _elements;
+    size_t _bytes;
+    uint64_t _start;
+  };
+
+  /// \return the current timestamp
+  static uint64_t now ()
+  {
+#ifdef VL_TRACE_USE_RDTSC
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+  }
+
+  /// \return the number of records kept for the calling thread
+  static size_t size ()
+  {
+    size_t head = local_ring().head.load(std::memory_order_relaxed);
+    return (head < RingSize) ? head : RingSize;
+  }
+
+  /// \param index index of a record, 0 is the oldest one that is kept
+  /// \return the record in the index, for the calling thread
+  static vl_trace_record record (size_t index)
+  {
+    ring& local = local_ring();
+    size_t first = local.head.load(std::memory_order_relaxed) - size();
+    vl_trace_record rec;
+    read_slot(local.slots[(first + index) % RingSize], rec);
+    return rec;
+  }
+
+  // clears the records of the calling thread
+  static void clear ()
+  {
+    ring& local = local_ring();
+    for (size_t i = 0; i < RingSize; i++)
+      {
+        local.slots[i].sequence.store(0, std::memory_order_relaxed);
+      }
+    local.head.store(0, std::memory_order_release);
+    local.counter = 0;
+  }
+
+  /// writes the records of all the threads as one Chrome trace event JSON,
+  /// that can be loaded by chrome://tracing or Perfetto. can be called from
+  /// any thread while the other threads keep tracing, records that are
+  /// overwritten while they are copied are skipped
+  /// \param out the stream to write to
+  /// \param ticks_per_us timestamp ticks in one microsecond, 1000 for
+  /// nanoseconds, the TSC frequency in MHz if VL_TRACE_USE_RDTSC is defined
+  /// \return the number of events that were written
+  static size_t write_chrome_trace (std::ostream& out,
+                                    double ticks_per_us = 1000.0)
+  {
+    static const char * names[] = {"realloc", "to_dynamic", "to_static",
+                                   "shift"};
+    const size_t names_num = sizeof(names) / sizeof(names[0]);
+    long pid = (long) getpid();
+    size_t written = 0;
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    for (ring * cur = _rings.load(std::memory_order_acquire); cur != nullptr;
+         cur = cur->next)
+      {
+        size_t head = cur->head.load(std::memory_order_acquire);
+        size_t first = (head < RingSize) ? 0 : head - RingSize;
+        for (size_t i = first; i < head; i++)
+          {
+            vl_trace_record rec;
+            size_t sequence = read_slot(cur->slots[i % RingSize], rec);
+            if (sequence != 2 * i + 2 || (size_t) rec.event >= names_num)
+              {
+                continue;
+              }
+            if (written > 0)
+              {
+                out << ",";
+              }
+            out << "\n{\"name\":\"" << names[(size_t) rec.event]
+                << "\",\"cat\":\"vl_vector\",\"ph\":\"X\""
+                << ",\"ts\":" << rec.start / ticks_per_us
+                << ",\"dur\":" << (rec.end - rec.start) / ticks_per_us
+                << ",\"pid\":" << pid << ",\"tid\":" << rec.tid
+                << ",\"args\":{\"elements\":" << rec.elements
+                << ",\"bytes\":" << rec.bytes << "}}";
+            written++;
+          }
+      }
+    out << "\n]}\n";
+    out.flags(flags);
+    out.precision(precision);
+    return written;
+  }
+
+ private:
+  /// copies a slot into a record
+  /// \param cur the slot to copy
+  /// \param rec the record to copy into
+  /// \return the sequence number of the copied record, or 1 (odd, never a
+  /// complete record) if the slot was written while it was copied
+  static size_t read_slot (const slot& cur, vl_trace_record& rec)
+  {
+    size_t before = cur.sequence.load(std::memory_order_acquire);
+    rec.event = (vl_vector_event) cur.event.load(std::memory_order_relaxed);
+    rec.elements = cur.elements.load(std::memory_order_relaxed);
+    rec.bytes = cur.bytes.load(std::memory_order_relaxed);
+    rec.start = cur.start.load(std::memory_order_relaxed);
+    rec.end = cur.end.load(std::memory_order_relaxed);
+    rec.tid = cur.tid.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t after = cur.sequence.load(std::memory_order_relaxed);
+    return (before == after && before % 2 == 0) ? before : 1;
+  }
+
+  // owns the ring of a thread, and frees it for reuse when the thread exits
+  struct ring_holder
+  {
+    ring * owned = nullptr;
+    ~ring_holder ()
+    {
+      if (owned != nullptr)
+        {
+          owned->in_use.store(false, std::memory_order_release);
+        }
+    }
+  };
+
+  /// \return the ring of the calling thread. on the first call of every
+  /// thread it takes a free ring, or creates and registers a new one
+  static ring& local_ring ()
+  {
+    static thread_local ring_holder holder;
+    if (holder.owned == nullptr)
+      {
+        holder.owned = acquire_ring();
+      }
+    return *holder.owned;
+  }
+
+  /// \return a free ring that is now owned by the calling thread
+  static ring * acquire_ring ()
+  {
+    long tid = (long) syscall(SYS_gettid);
+    for (ring * cur = _rings.load(std::memory_order_acquire); cur != nullptr;
+         cur = cur->next)
+      {
+        bool expected = false;
+        if (cur->in_use.compare_exchange_strong(expected, true,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed))
+          {
+            cur->tid = tid;
+            cur->counter = 0;
+            return cur;
+          }
+      }
+    ring * created = new ring();
+    created->in_use.store(true, std::memory_order_relaxed);
+    created->tid = tid;
+    created->next = _rings.load(std::memory_order_relaxed);
+    while (!_rings.compare_exchange_weak(created->next, created,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed))
+      {
+      }
+    return created;
+  }
+
+  static std::atomic<ring *> _rings;
+};
+
+template <size_t RingSize, size_t SampleEvery>
+std::atomic<typename vl_vector_tracer<RingSize, SampleEvery>::ring *>
+    vl_vector_tracer<RingSize, SampleEvery>::_rings(nullptr);
+#endif //_VL_VECTOR_TRACE_H_